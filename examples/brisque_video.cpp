@@ -20,6 +20,10 @@
  * in your video. It will simply output the frame number and the
  * video quality value reported by Brisque in that frame.
  *
+ * Brisque is a lot slower than decoding, so the frames are scored
+ * on a pool of threads with parallel_frame_map. Scores still come
+ * out in frame order.
+ *
  * * Requires libsvm
  */
 
@@ -28,13 +32,19 @@
 #include <functional>
 #include <libsvm/svm.h>
 #include <fr/media/decoder>
-#include <fr/media/frame2cv>
+#include <fr/media/parallel_frame_map>
+
+// Runs in one of parallel_frame_map's worker threads
+float brisque_score(cv::Mat &frame, svm_model *model)
+{
+  return jd_brisque::computescore(frame, model);
+}
 
-void brisque_frame_callback(cv::Mat frame, svm_model *model, long *framecount)
+// Runs in frame order
+void brisque_frame_callback(size_t index, int64_t pts, float score, long *framecount)
 {
   (*framecount)++;
-  float score = jd_brisque::computescore(frame, model);
-  std::cout << "Frame " << (*framecount) << " score " << score << std::endl;
+  std::cout << "Frame " << (index + 1) << " pts " << pts << " score " << score << std::endl;
 }
 
 void print_help(char *arg0)
@@ -63,13 +73,16 @@ int main(int argc, char *argv[])
       }
       std::cout << "Opening " << std::string(argv[1]) << std::endl;
       fr::media::decoder::pointer video = fr::media::decoder::create(argv[1]);
-      fr::media::frame2cv::pointer converter = fr::media::frame2cv::create(); // convert frames to mats
-      video->add(converter);
-      converter->available.connect(std::bind(&brisque_frame_callback, std::placeholders::_1, model, &framecount));
+      // Score frames on one thread per core
+      fr::media::parallel_frame_map<float>::pointer scorer = fr::media::parallel_frame_map<float>::create(std::bind(&brisque_score, std::placeholders::_1, model));
+      video->add(scorer);
+      scorer->available.connect(std::bind(&brisque_frame_callback, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, &framecount));
 
       std::chrono::high_resolution_clock::time_point run_start = std::chrono::high_resolution_clock::now();
       video->process();
       video->join();
+      // Wait for the workers to finish scoring what the decoder gave them
+      scorer->wait();
 
       std::chrono::high_resolution_clock::time_point run_end = std::chrono::high_resolution_clock::now();
       size_t total_millis = std::chrono::duration_cast<std::chrono::milliseconds>(run_end - run_start).count();
@@ -22,8 +22,11 @@
 #include <fr/media/audio_decoder_subscriber>
 #include <fr/media/decoder>
 #include <fr/media/video_decoder_subscriber>
+#include <chrono>
 #include <functional>
 #include <memory>
+#include <thread>
+#include "video_counter.h"
 
 // Now I know what you're thinking. You're thinking if I multiply-inherit
 // video and audio subscribers, I'm going to have a conflict in subscribe.
@@ -121,11 +124,21 @@ public:
   
 };
 
+// The test video is WebM, which always uses millisecond timestamps
+static const int64_t webm_ticks_per_second = 1000;
+
+// At 30 FPS, one frame is 33 or 34 ms. Anything bigger than this
+// means we skipped frames.
+static const int64_t one_frame_gap = 50;
+
 class decoder_test : public CppUnit::TestFixture {
 
   CPPUNIT_TEST_SUITE(decoder_test);
   CPPUNIT_TEST(count_packets);
   CPPUNIT_TEST(destroy_listener_before_decoder);
+  CPPUNIT_TEST(live_paced_replay);
+  CPPUNIT_TEST(live_drops_late_frames);
+  CPPUNIT_TEST(slow_subscriber_without_live_mode);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -165,6 +178,73 @@ public:
     CPPUNIT_ASSERT(true);
   }
 
+  // Replay the test video at its native rate for a couple of seconds.
+  // It's 30 FPS, so we should see about 60 frames rather than all 300
+  // of them.
+  void live_paced_replay()
+  {
+    auto decoder = fr::media::decoder::create(TEST_VIDEO);
+    auto helper = video_counter::create();
+    decoder->set_live_mode(std::chrono::milliseconds(200), true);
+    decoder->add(helper);
+    decoder->process();
+    std::this_thread::sleep_for(std::chrono::seconds(2));
+    decoder->shutdown();
+    decoder->join();
+    BOOST_LOG_TRIVIAL(info) << "Paced replay delivered " << decoder->frames_delivered() << " frames, dropped " << decoder->frames_dropped();
+    BOOST_LOG_TRIVIAL(info) << "Max latency: " << decoder->max_latency().count() << " us";
+    CPPUNIT_ASSERT(helper->video_packet_count > 0);
+    CPPUNIT_ASSERT(helper->video_packet_count < 100);
+    CPPUNIT_ASSERT(helper->video_packet_count == decoder->frames_delivered());
+  }
+
+  // A subscriber that can only handle 10 frames a second can't keep
+  // up with a 30 FPS source, so the decoder should drop frames to
+  // stay within its latency budget. We check the latency the
+  // subscriber actually sees, not what the decoder thinks it is.
+  void live_drops_late_frames()
+  {
+    auto decoder = fr::media::decoder::create(TEST_VIDEO);
+    auto helper = video_counter::create(std::chrono::milliseconds(100));
+    decoder->set_live_mode(std::chrono::milliseconds(150), true);
+    decoder->add(helper);
+    decoder->process();
+    std::this_thread::sleep_for(std::chrono::seconds(2));
+    decoder->shutdown();
+    decoder->join();
+    std::chrono::microseconds seen = helper->max_lateness(webm_ticks_per_second);
+    BOOST_LOG_TRIVIAL(info) << "Slow subscriber got " << decoder->frames_delivered() << " frames, dropped " << decoder->frames_dropped();
+    BOOST_LOG_TRIVIAL(info) << "Max latency seen by subscriber: " << seen.count() << " us";
+    CPPUNIT_ASSERT(helper->video_packet_count > 1);
+    CPPUNIT_ASSERT(decoder->frames_dropped() > 0);
+    CPPUNIT_ASSERT(helper->max_timestamp_gap() > one_frame_gap);
+    // The decoder checks latency a little before our callback runs,
+    // and the machine running the test might be busy. Allow a frame
+    // or so on top of the budget for that. Without live mode this
+    // climbs by about 67 ms every frame.
+    CPPUNIT_ASSERT(seen <= std::chrono::milliseconds(150 + 50));
+  }
+
+  // Same slow subscriber without live mode. Nothing gets dropped, so
+  // the subscriber falls further and further behind.
+  void slow_subscriber_without_live_mode()
+  {
+    auto decoder = fr::media::decoder::create(TEST_VIDEO);
+    auto helper = video_counter::create(std::chrono::milliseconds(100));
+    decoder->add(helper);
+    decoder->process();
+    std::this_thread::sleep_for(std::chrono::seconds(2));
+    decoder->shutdown();
+    decoder->join();
+    std::chrono::microseconds seen = helper->max_lateness(webm_ticks_per_second);
+    BOOST_LOG_TRIVIAL(info) << "Slow subscriber without live mode got " << helper->video_packet_count << " frames";
+    BOOST_LOG_TRIVIAL(info) << "Max latency seen by subscriber: " << seen.count() << " us";
+    CPPUNIT_ASSERT(helper->video_packet_count > 1);
+    CPPUNIT_ASSERT(0 == decoder->frames_dropped());
+    CPPUNIT_ASSERT(helper->max_timestamp_gap() <= one_frame_gap);
+    CPPUNIT_ASSERT(seen > std::chrono::milliseconds(150));
+  }
+
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(decoder_test);
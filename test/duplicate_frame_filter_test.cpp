@@ -0,0 +1,140 @@
+/**
+ * Copyright 2019 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * Test duplicate_frame_filter, first with some frames we make up so we
+ * know exactly what should get through, then with the motion test
+ * video to see how much a static camera saves us.
+ */
+
+#include <boost/log/trivial.hpp>
+#include <cmath>
+#include <cppunit/extensions/HelperMacros.h>
+#include <fr/media/decoder>
+#include <fr/media/duplicate_frame_filter>
+#include <memory>
+#include <vector>
+#include "video_counter.h"
+
+class duplicate_frame_filter_test : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(duplicate_frame_filter_test);
+  CPPUNIT_TEST(synthetic_frames_test);
+  CPPUNIT_TEST(max_skip_test);
+  CPPUNIT_TEST(static_camera_test);
+  CPPUNIT_TEST_SUITE_END();
+
+  static const int width = 64;
+  static const int height = 48;
+
+  // A gray frame that gets brighter left to right, or right to left
+  // if reversed is set. Those two hash as different as two frames
+  // can be.
+  AVFrame *make_frame(std::vector<uint8_t> &pixels, bool reversed)
+  {
+    pixels.resize(width * height);
+    for (int y = 0 ; y < height; ++y) {
+      for (int x = 0 ; x < width; ++x) {
+	int brightness = x * 255 / (width - 1);
+	pixels[y * width + x] = (uint8_t) (reversed ? 255 - brightness : brightness);
+      }
+    }
+    AVFrame *frame = av_frame_alloc();
+    frame->format = AV_PIX_FMT_GRAY8;
+    frame->width = width;
+    frame->height = height;
+    frame->data[0] = pixels.data();
+    frame->linesize[0] = width;
+    return frame;
+  }
+
+public:
+
+  void synthetic_frames_test()
+  {
+    std::vector<uint8_t> forward_pixels;
+    std::vector<uint8_t> reverse_pixels;
+    AVFrame *forward_frame = make_frame(forward_pixels, false);
+    AVFrame *reverse_frame = make_frame(reverse_pixels, true);
+
+    CPPUNIT_ASSERT(fr::media::duplicate_frame_filter::hashable(forward_frame));
+    uint64_t forward_hash = fr::media::duplicate_frame_filter::hash(forward_frame);
+    uint64_t reverse_hash = fr::media::duplicate_frame_filter::hash(reverse_frame);
+    CPPUNIT_ASSERT(0 == fr::media::duplicate_frame_filter::distance(forward_hash, forward_hash));
+    CPPUNIT_ASSERT(64 == fr::media::duplicate_frame_filter::distance(forward_hash, reverse_hash));
+
+    auto filter = fr::media::duplicate_frame_filter::create();
+    auto counter = video_counter::create();
+    filter->add(counter);
+
+    // First frame always gets through, the next four are duplicates
+    for (int i = 0 ; i < 5; ++i) {
+      filter->video_available_cb(forward_frame);
+    }
+    CPPUNIT_ASSERT(1 == counter->video_packet_count);
+    filter->video_available_cb(reverse_frame);
+    CPPUNIT_ASSERT(2 == counter->video_packet_count);
+    CPPUNIT_ASSERT(6 == filter->frames_received());
+    CPPUNIT_ASSERT(2 == filter->frames_forwarded());
+
+    // Data belongs to the vectors, so don't let av_frame_free touch it
+    forward_frame->data[0] = nullptr;
+    reverse_frame->data[0] = nullptr;
+    av_frame_free(&forward_frame);
+    av_frame_free(&reverse_frame);
+  }
+
+  // Even identical frames get through every max_skip + 1 frames
+  void max_skip_test()
+  {
+    std::vector<uint8_t> pixels;
+    AVFrame *frame = make_frame(pixels, false);
+    auto filter = fr::media::duplicate_frame_filter::create(2, 4);
+    auto counter = video_counter::create();
+    filter->add(counter);
+
+    for (int i = 0 ; i < 20; ++i) {
+      filter->video_available_cb(frame);
+    }
+    CPPUNIT_ASSERT(4 == counter->video_packet_count);
+    CPPUNIT_ASSERT(std::abs(filter->suppression_ratio() - 0.8) < 0.0001);
+
+    frame->data[0] = nullptr;
+    av_frame_free(&frame);
+  }
+
+  // The motion test video is mostly an empty room. Log how much of it
+  // we drop, and make sure max_skip still lets frames through.
+  void static_camera_test()
+  {
+    auto decoder = fr::media::decoder::create(TEST_VIDEO);
+    auto filter = fr::media::duplicate_frame_filter::create();
+    auto counter = video_counter::create();
+    decoder->add(filter);
+    filter->add(counter);
+    decoder->process();
+    decoder->join();
+
+    BOOST_LOG_TRIVIAL(info) << "Received " << filter->frames_received() << " frames, forwarded " << filter->frames_forwarded();
+    BOOST_LOG_TRIVIAL(info) << "Suppression ratio: " << filter->suppression_ratio();
+    CPPUNIT_ASSERT(filter->frames_received() > 0);
+    CPPUNIT_ASSERT(counter->video_packet_count == filter->frames_forwarded());
+    CPPUNIT_ASSERT(filter->suppression_ratio() > 0.0);
+    // With max_skip at 30, at least one frame in 31 has to get through
+    CPPUNIT_ASSERT(filter->frames_forwarded() >= filter->frames_received() / 31);
+  }
+
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(duplicate_frame_filter_test);
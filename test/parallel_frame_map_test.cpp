@@ -0,0 +1,126 @@
+/**
+ * Copyright 2019 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * Test parallel_frame_map. Results should come out in frame order
+ * and match what we get running the same function one frame at a
+ * time in a frame2cv callback.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cppunit/extensions/HelperMacros.h>
+#include <fr/media/decoder>
+#include <fr/media/frame2cv>
+#include <fr/media/parallel_frame_map>
+#include <memory>
+#include <thread>
+#include <vector>
+
+class parallel_frame_map_test : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(parallel_frame_map_test);
+  CPPUNIT_TEST(ordered_results_test);
+  CPPUNIT_TEST(window_test);
+  CPPUNIT_TEST_SUITE_END();
+
+  // Something cheap to compute that's different for every frame
+  static double frame_sum(cv::Mat &frame)
+  {
+    return cv::sum(frame)[0];
+  }
+
+public:
+
+  // Make the workers finish out of order by sleeping for a different
+  // amount of time on each frame. We should still get everything in
+  // order.
+
+  void ordered_results_test()
+  {
+    std::vector<double> expected;
+    auto decoder = fr::media::decoder::create(TEST_VIDEO);
+    auto converter = fr::media::frame2cv::create();
+    decoder->add(converter);
+    converter->available.connect([&expected](cv::Mat frame) { expected.push_back(frame_sum(frame)); });
+    decoder->process();
+    decoder->join();
+
+    std::atomic<size_t> calls(0l);
+    std::vector<size_t> indexes;
+    std::vector<int64_t> timestamps;
+    std::vector<double> results;
+    auto parallel_decoder = fr::media::decoder::create(TEST_VIDEO);
+    auto mapper = fr::media::parallel_frame_map<double>::create([&calls](cv::Mat &frame) {
+	size_t call = calls++;
+	std::this_thread::sleep_for(std::chrono::milliseconds(call % 4));
+	return frame_sum(frame);
+      }, 4);
+    mapper->available.connect([&indexes, &timestamps, &results](size_t index, int64_t pts, double result) {
+	indexes.push_back(index);
+	timestamps.push_back(pts);
+	results.push_back(result);
+      });
+    parallel_decoder->add(mapper);
+    parallel_decoder->process();
+    parallel_decoder->join();
+    mapper->wait();
+
+    CPPUNIT_ASSERT(expected.size() > 0);
+    CPPUNIT_ASSERT(results == expected);
+    for (size_t i = 0 ; i < indexes.size(); ++i) {
+      CPPUNIT_ASSERT(indexes[i] == i);
+      if (i > 0) {
+	CPPUNIT_ASSERT(timestamps[i] > timestamps[i - 1]);
+      }
+    }
+  }
+
+  // We should never have more frames in the function than the window
+  // allows, even with more workers than that.
+
+  void window_test()
+  {
+    std::atomic<int> running(0);
+    std::atomic<int> max_running(0);
+    size_t emitted = 0l;
+    auto decoder = fr::media::decoder::create(TEST_VIDEO);
+    auto mapper = fr::media::parallel_frame_map<int>::create([&running, &max_running](cv::Mat &frame) {
+	int now_running = ++running;
+	int seen = max_running.load();
+	while (now_running > seen && !max_running.compare_exchange_weak(seen, now_running)) {
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	running--;
+	return frame.rows;
+      }, 4, 2);
+    mapper->available.connect([&emitted](size_t index, int64_t pts, int rows) { emitted++; });
+    decoder->add(mapper);
+
+    std::chrono::steady_clock::time_point test_start = std::chrono::steady_clock::now();
+    decoder->process();
+    decoder->join();
+    mapper->wait();
+    std::chrono::steady_clock::time_point test_end = std::chrono::steady_clock::now();
+    size_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(test_end - test_start).count();
+
+    BOOST_LOG_TRIVIAL(info) << "Mapped " << emitted << " frames in " << ms << " ms, at most " << max_running.load() << " at once";
+    CPPUNIT_ASSERT(emitted > 0);
+    CPPUNIT_ASSERT(max_running.load() <= 2);
+    CPPUNIT_ASSERT(0 == mapper->in_flight());
+  }
+
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(parallel_frame_map_test);
@@ -0,0 +1,161 @@
+/**
+ * Copyright 2019 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * Make sure the decoder remembers sources it's opened before, and
+ * can still decode them when it skips probing.
+ */
+
+#include <boost/log/trivial.hpp>
+#include <cppunit/extensions/HelperMacros.h>
+#include <fr/media/decoder>
+#include <fr/media/probe_cache>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include "video_counter.h"
+
+class probe_cache_test : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(probe_cache_test);
+  CPPUNIT_TEST(reopen_uses_cache);
+  CPPUNIT_TEST(bad_source_not_cached);
+  CPPUNIT_TEST(missing_source_keeps_entry);
+  CPPUNIT_TEST(changed_container_probed_again);
+  CPPUNIT_TEST_SUITE_END();
+
+  void log_timing(const std::string &label, const fr::media::open_timing &timing)
+  {
+    BOOST_LOG_TRIVIAL(info) << label << (timing.cache_hit ? " (cached)" : " (probed)")
+			    << ": open input " << timing.open_input.count() << " us"
+			    << ", stream info " << timing.stream_info.count() << " us"
+			    << ", open codecs " << timing.open_codecs.count() << " us"
+			    << ", total " << timing.total.count() << " us";
+  }
+
+  // Decodes source using cache and returns how many video frames we got
+  size_t decode_with(fr::media::probe_cache::pointer cache, fr::media::open_timing &timing, const std::string &source = TEST_VIDEO)
+  {
+    auto decoder = fr::media::decoder::create(source);
+    auto counter = video_counter::create();
+    decoder->set_probe_cache(cache);
+    decoder->add(counter);
+    decoder->process();
+    timing = decoder->open_times();
+    decoder->join();
+    return counter->video_packet_count;
+  }
+
+  void copy_file(const std::string &from, const std::string &to)
+  {
+    std::ifstream original(from, std::ios::binary);
+    std::ofstream copy(to, std::ios::binary);
+    copy << original.rdbuf();
+  }
+
+public:
+
+  void reopen_uses_cache()
+  {
+    auto cache = fr::media::probe_cache::create();
+    fr::media::open_timing first_timing;
+    fr::media::open_timing second_timing;
+
+    size_t first_frames = decode_with(cache, first_timing);
+    log_timing("First open", first_timing);
+    CPPUNIT_ASSERT(!first_timing.cache_hit);
+    CPPUNIT_ASSERT(cache->size() == 1);
+
+    size_t second_frames = decode_with(cache, second_timing);
+    log_timing("Second open", second_timing);
+    CPPUNIT_ASSERT(second_timing.cache_hit);
+
+    CPPUNIT_ASSERT(first_frames > 0);
+    CPPUNIT_ASSERT(first_frames == second_frames);
+  }
+
+  // Opening something that isn't there should fail without hanging
+  // around trying every demuxer, and shouldn't end up in the cache.
+  void bad_source_not_cached()
+  {
+    auto cache = fr::media::probe_cache::create();
+    auto decoder = fr::media::decoder::create(OUTPUT_DIR "/no_such_video.webm");
+    decoder->set_probe_cache(cache);
+    decoder->process();
+    log_timing("Bad source", decoder->open_times());
+    decoder->join();
+    CPPUNIT_ASSERT(cache->size() == 0);
+    CPPUNIT_ASSERT(!decoder->open_times().cache_hit);
+  }
+
+  // If a source we remember goes away for a bit, failing to open it
+  // doesn't mean what we remember about it is wrong. We should still
+  // have it when the source comes back.
+  void missing_source_keeps_entry()
+  {
+    const std::string copy_path = OUTPUT_DIR "/probe_cache_copy.webm";
+    copy_file(TEST_VIDEO, copy_path);
+    auto cache = fr::media::probe_cache::create();
+    fr::media::open_timing timing;
+    CPPUNIT_ASSERT(decode_with(cache, timing, copy_path) > 0);
+    CPPUNIT_ASSERT(cache->size() == 1);
+
+    std::rename(copy_path.c_str(), (copy_path + ".away").c_str());
+    auto decoder = fr::media::decoder::create(copy_path);
+    decoder->set_probe_cache(cache);
+    decoder->process();
+    log_timing("Missing source", decoder->open_times());
+    decoder->join();
+    CPPUNIT_ASSERT(cache->size() == 1);
+
+    std::rename((copy_path + ".away").c_str(), copy_path.c_str());
+    CPPUNIT_ASSERT(decode_with(cache, timing, copy_path) > 0);
+    log_timing("Source back", timing);
+    CPPUNIT_ASSERT(timing.cache_hit);
+    std::remove(copy_path.c_str());
+  }
+
+  // Replace a source we remember with something in a different
+  // container. We shouldn't force the old demuxer on it, and we
+  // should still be able to decode it.
+  void changed_container_probed_again()
+  {
+    const std::string source = OUTPUT_DIR "/probe_cache_changed";
+    copy_file(TEST_VIDEO, source);
+    auto cache = fr::media::probe_cache::create();
+    fr::media::open_timing timing;
+    CPPUNIT_ASSERT(decode_with(cache, timing, source) > 0);
+    auto video_entry = cache->find(source);
+    CPPUNIT_ASSERT(nullptr != video_entry.get());
+
+    copy_file(TEST_AUDIO, source);
+    size_t audio_frames = 0l;
+    auto decoder = fr::media::decoder::create(source);
+    decoder->set_probe_cache(cache);
+    decoder->audio_available.connect([&audio_frames](AVFrame *frame) { audio_frames++; });
+    decoder->process();
+    log_timing("Changed container", decoder->open_times());
+    decoder->join();
+    std::remove(source.c_str());
+
+    CPPUNIT_ASSERT(!decoder->open_times().cache_hit);
+    CPPUNIT_ASSERT(audio_frames > 0);
+    auto audio_entry = cache->find(source);
+    CPPUNIT_ASSERT(nullptr != audio_entry.get());
+    CPPUNIT_ASSERT(audio_entry->input_format != video_entry->input_format);
+  }
+
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(probe_cache_test);
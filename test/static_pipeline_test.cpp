@@ -0,0 +1,155 @@
+/**
+ * Copyright 2019 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * Test static_pipeline. Makes sure it gets the same answers as wiring
+ * the same objects together with signals, and times the two against
+ * each other.
+ */
+
+#include <chrono>
+#include <cppunit/extensions/HelperMacros.h>
+#include <fr/media/decoder>
+#include <fr/media/frame2cv>
+#include <fr/media/motion_detector>
+#include <fr/media/static_pipeline>
+#include <memory>
+#include <vector>
+
+// Does nothing but count and pass the frame along. Used to measure
+// what it costs to get from one stage to the next.
+
+class pass_through {
+
+public:
+
+  typedef std::shared_ptr<pass_through> pointer;
+
+  size_t count;
+
+  pass_through() : count(0l)
+  {
+  }
+
+  static pointer create()
+  {
+    return std::make_shared<pass_through>();
+  }
+
+  template <typename Next>
+  void process(Next &next, const cv::Mat &frame)
+  {
+    count++;
+    next(frame);
+  }
+
+};
+
+class static_pipeline_test : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(static_pipeline_test);
+  CPPUNIT_TEST(same_as_signals_test);
+  CPPUNIT_TEST(dispatch_timing_test);
+  CPPUNIT_TEST_SUITE_END();
+
+  static const size_t dispatch_iterations = 100000;
+
+public:
+
+  // Run the motion test video through decoder -> frame2cv -> motion detector
+  // both ways. We should detect motion in exactly the same frames.
+
+  void same_as_signals_test()
+  {
+    std::vector<size_t> signal_detections;
+    std::vector<size_t> static_detections;
+
+    auto decoder = fr::media::decoder::create(TEST_VIDEO);
+    auto converter = fr::media::frame2cv::create();
+    auto detector = fr::media::static_bg_motion_detector::create();
+    decoder->add(converter);
+    detector->subscribe(converter);
+    detector->available.connect([&signal_detections](cv::Mat frame, size_t frameno, std::vector<std::vector<cv::Point>> contours) { signal_detections.push_back(frameno); });
+
+    std::chrono::steady_clock::time_point signal_start = std::chrono::steady_clock::now();
+    decoder->process();
+    decoder->join();
+    std::chrono::steady_clock::time_point signal_end = std::chrono::steady_clock::now();
+
+    auto static_decoder = fr::media::decoder::create(TEST_VIDEO);
+    auto pipeline = fr::media::make_static_pipeline([&static_detections](const cv::Mat &frame, size_t frameno, std::vector<std::vector<cv::Point>> &contours) { static_detections.push_back(frameno); },
+						    fr::media::frame2cv::create(),
+						    fr::media::static_bg_motion_detector::create());
+    pipeline->subscribe(static_decoder);
+
+    std::chrono::steady_clock::time_point static_start = std::chrono::steady_clock::now();
+    static_decoder->process();
+    static_decoder->join();
+    std::chrono::steady_clock::time_point static_end = std::chrono::steady_clock::now();
+
+    size_t signal_ms = std::chrono::duration_cast<std::chrono::milliseconds>(signal_end - signal_start).count();
+    size_t static_ms = std::chrono::duration_cast<std::chrono::milliseconds>(static_end - static_start).count();
+    BOOST_LOG_TRIVIAL(info) << "Signal pipeline: " << signal_detections.size() << " detections in " << signal_ms << " ms";
+    BOOST_LOG_TRIVIAL(info) << "Static pipeline: " << static_detections.size() << " detections in " << static_ms << " ms";
+
+    CPPUNIT_ASSERT(signal_detections.size() > 0);
+    CPPUNIT_ASSERT(signal_detections == static_detections);
+  }
+
+  // Push the same small mat through three do-nothing stages with signals
+  // and with a static pipeline, so all we're measuring is the cost of
+  // getting from one stage to the next.
+
+  void dispatch_timing_test()
+  {
+    cv::Mat frame(16, 16, CV_8UC3, cv::Scalar(0, 0, 0));
+    size_t signal_count = 0l;
+    size_t static_count = 0l;
+
+    boost::signals2::signal<void(cv::Mat)> first;
+    boost::signals2::signal<void(cv::Mat)> second;
+    boost::signals2::signal<void(cv::Mat)> third;
+    first.connect([&second](cv::Mat frame) { second(frame); });
+    second.connect([&third](cv::Mat frame) { third(frame); });
+    third.connect([&signal_count](cv::Mat frame) { signal_count++; });
+
+    std::chrono::steady_clock::time_point signal_start = std::chrono::steady_clock::now();
+    for (size_t i = 0 ; i < dispatch_iterations; ++i) {
+      first(frame);
+    }
+    std::chrono::steady_clock::time_point signal_end = std::chrono::steady_clock::now();
+
+    auto pipeline = fr::media::make_static_pipeline([&static_count](const cv::Mat &frame) { static_count++; },
+						    pass_through::create(),
+						    pass_through::create(),
+						    pass_through::create());
+
+    std::chrono::steady_clock::time_point static_start = std::chrono::steady_clock::now();
+    for (size_t i = 0 ; i < dispatch_iterations; ++i) {
+      pipeline->push(frame);
+    }
+    std::chrono::steady_clock::time_point static_end = std::chrono::steady_clock::now();
+
+    size_t signal_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(signal_end - signal_start).count();
+    size_t static_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(static_end - static_start).count();
+    BOOST_LOG_TRIVIAL(info) << "Signal dispatch: " << (signal_ns / dispatch_iterations) << " ns per frame";
+    BOOST_LOG_TRIVIAL(info) << "Static dispatch: " << (static_ns / dispatch_iterations) << " ns per frame";
+
+    CPPUNIT_ASSERT(signal_count == dispatch_iterations);
+    CPPUNIT_ASSERT(static_count == dispatch_iterations);
+  }
+
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(static_pipeline_test);
@@ -0,0 +1,95 @@
+/**
+ * Copyright 2019 Bruce Ide
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * A video subscriber a bunch of the tests use. It counts the video
+ * frames it gets and remembers each frame's pts and when it showed
+ * up. It can also take its sweet time with each frame, if you want
+ * to see what happens when a subscriber can't keep up.
+ */
+
+#ifndef _HPP_FR_MEDIA_TEST_VIDEO_COUNTER
+#define _HPP_FR_MEDIA_TEST_VIDEO_COUNTER
+
+#include <chrono>
+#include <fr/media/video_decoder_subscriber>
+#include <memory>
+#include <thread>
+#include <vector>
+
+class video_counter : public fr::media::video_decoder_subscriber {
+
+  std::chrono::milliseconds delay;
+
+public:
+
+  typedef std::shared_ptr<video_counter> pointer;
+
+  size_t video_packet_count;
+  std::vector<int64_t> timestamps;
+  std::vector<std::chrono::steady_clock::time_point> arrivals;
+
+  video_counter(std::chrono::milliseconds delay) : delay(delay), video_packet_count(0l)
+  {
+  }
+
+  virtual ~video_counter()
+  {
+  }
+
+  static pointer create(std::chrono::milliseconds delay = std::chrono::milliseconds(0))
+  {
+    return std::make_shared<video_counter>(delay);
+  }
+
+  void video_available_cb(AVFrame *frame) override
+  {
+    video_packet_count++;
+    timestamps.push_back(frame->best_effort_timestamp);
+    arrivals.push_back(std::chrono::steady_clock::now());
+    std::this_thread::sleep_for(delay);
+  }
+
+  // How far behind the source the worst frame showed up, measured
+  // from the first frame we got. ticks_per_second is the stream's
+  // time base (1000 for WebM.)
+  std::chrono::microseconds max_lateness(int64_t ticks_per_second) const
+  {
+    std::chrono::microseconds worst(0);
+    for (size_t i = 1 ; i < timestamps.size(); ++i) {
+      std::chrono::microseconds source_elapsed((timestamps[i] - timestamps[0]) * 1000000 / ticks_per_second);
+      std::chrono::microseconds wall_elapsed = std::chrono::duration_cast<std::chrono::microseconds>(arrivals[i] - arrivals[0]);
+      if (wall_elapsed - source_elapsed > worst) {
+	worst = wall_elapsed - source_elapsed;
+      }
+    }
+    return worst;
+  }
+
+  // Biggest jump in pts between two frames we got in a row. If no
+  // frames were dropped, this is one frame's worth.
+  int64_t max_timestamp_gap() const
+  {
+    int64_t gap = 0l;
+    for (size_t i = 1 ; i < timestamps.size(); ++i) {
+      if (timestamps[i] - timestamps[i - 1] > gap) {
+	gap = timestamps[i] - timestamps[i - 1];
+      }
+    }
+    return gap;
+  }
+
+};
+
+#endif